@@ -0,0 +1,220 @@
+#!/usr/bin/env python3
+"""
+ File: fpsnap.py
+
+ Description: Decodes the frame pool snapshots that
+ ContFramePool::snapshot_all() writes to the debug port, and prints a
+ fragmentation heatmap of every pool.
+
+ Usage: fpsnap.py [-w WIDTH] [-r ROWS] [-a] [FILE ...]
+
+ FILE is the captured debug port output, e.g. the console output of
+ Bochs (port_e9_hack in bochsrc.bxrc) or the file of
+ "qemu-system-i386 -debugcon file:e9.txt". It may contain other text,
+ such as the kernel log; only the "fps" lines are read. Without -a,
+ only the last complete snapshot is shown.
+
+ In the heatmap every character stands for the same number of frames:
+   '#'  all frames used
+   '.'  all frames free
+   1-9  partly free, in tenths of the frames (rounded up)
+ The size-class table then shows which runs the free frames are in, and
+ so why a large get_frames() fails although there is enough free memory.
+
+ Only the Python 3 standard library is used.
+"""
+
+import argparse
+import re
+import sys
+
+POLICIES = ["FIRST_FIT", "NEXT_FIT", "BEST_FIT"]
+
+LINE = re.compile(r"fps ([A-Z])((?: [0-9a-f]+)*)")
+
+
+def read_snapshots(lines):
+    """Returns the complete snapshots in lines, as lists of pools."""
+    snapshots = []
+    pools = None
+    pool = None
+    for text in lines:
+        m = LINE.search(text)
+        if m is None:
+            continue
+        kind = m.group(1)
+        values = [int(x, 16) for x in m.group(2).split()]
+        if kind == "B":
+            pools = []
+        elif pools is None:
+            continue                # the start of the snapshot is missing
+        elif kind == "Z":
+            snapshots.append(pools)
+            pools = None
+        elif kind == "P":
+            pool = {"id": values[0], "base": values[1], "frames": values[2],
+                    "info_frame": values[3], "info_frames": values[4],
+                    "free": values[5], "extents": values[6],
+                    "largest": values[7], "policy": values[8],
+                    "runs": []}
+            pools.append(pool)
+        elif pool is None:
+            continue
+        elif kind == "Q":
+            pool["quicklist"] = values[0:2]
+            pool["zeroed"], pool["shared"], pool["movable"] = values[2:5]
+        elif kind == "S":
+            (pool["failed"], pool["steps"], pool["max_steps"],
+             pool["high_water"]) = values
+        elif kind == "A":
+            pool["allocs"] = values
+        elif kind == "F":
+            pool["frees"] = values
+        elif kind == "R":
+            pool["runs"].extend(values)
+        elif kind == "X":
+            pool["n_runs"] = values[0]
+            pool = None
+    return snapshots
+
+
+def free_runs(pool):
+    """Returns the (first frame index, length) of every free run."""
+    runs = []
+    index = 0
+    for i, length in enumerate(pool["runs"]):
+        if i % 2 == 1 and length > 0:
+            runs.append((index, length))
+        index += length
+    return runs
+
+
+def check(pool):
+    """Returns a list of the inconsistencies in the snapshot of pool."""
+    problems = []
+    if pool.get("n_runs") != len(pool["runs"]):
+        problems.append("map has %d runs, pool wrote %s"
+                        % (len(pool["runs"]), pool.get("n_runs")))
+    if sum(pool["runs"]) != pool["frames"]:
+        problems.append("map covers %d frames, pool has %d"
+                        % (sum(pool["runs"]), pool["frames"]))
+    free = sum(pool["runs"][1::2])
+    if free != pool["free"]:
+        problems.append("map has %d free frames, pool counts %d"
+                        % (free, pool["free"]))
+    return problems
+
+
+def heatmap(pool, width, rows):
+    """Returns the lines of the heatmap of pool."""
+    frames = pool["frames"]
+    cell = max(1, -(-frames // (width * rows)))
+    cells = -(-frames // cell)
+    free = [0] * cells
+    for first, length in free_runs(pool):
+        end = first + length
+        while first < end:
+            c = first // cell
+            step = min(end, (c + 1) * cell) - first
+            free[c] += step
+            first += step
+
+    lines = ["%d frames per character" % cell]
+    for row in range(0, cells, width):
+        text = ""
+        for c in range(row, min(row + width, cells)):
+            size = min(cell, frames - c * cell)
+            if free[c] == 0:
+                text += "#"
+            elif free[c] == size:
+                text += "."
+            else:
+                text += str(min(9, -(-free[c] * 10 // size)))
+        lines.append("%08x %s" % (pool["base"] + row * cell, text))
+    return lines
+
+
+def size_classes(pool):
+    """Returns the lines of the table of free runs by size class."""
+    counts = {}
+    for _, length in free_runs(pool):
+        k = length.bit_length() - 1
+        n, f = counts.get(k, (0, 0))
+        counts[k] = (n + 1, f + length)
+
+    lines = ["%-14s %8s %10s" % ("run length", "runs", "frames")]
+    for k in sorted(counts):
+        n, f = counts[k]
+        lines.append("%-14s %8d %10d" % ("%d-%d" % (1 << k, (2 << k) - 1),
+                                         n, f))
+    return lines
+
+
+def print_pool(pool, width, rows):
+    frames = pool["frames"]
+    policy = pool["policy"]
+    print("pool %d: frames %x-%x (%d frames), info frames %x (+%d), %s"
+          % (pool["id"], pool["base"], pool["base"] + frames - 1, frames,
+             pool["info_frame"] or pool["base"], pool["info_frames"],
+             POLICIES[policy] if policy < len(POLICIES) else policy))
+    print("  free %d (%.1f%%), %d extents, largest run %d"
+          % (pool["free"], 100.0 * pool["free"] / frames, pool["extents"],
+             pool["largest"]))
+    if "quicklist" in pool:
+        print("  quicklists %d + %d, zeroed reserve %d, shared frames %d,"
+              " movable sequences %d"
+              % (pool["quicklist"][0], pool["quicklist"][1], pool["zeroed"],
+                 pool["shared"], pool["movable"]))
+    if "failed" in pool:
+        print("  failed allocations %d, search steps %d (at most %d),"
+              " high-water mark %d"
+              % (pool["failed"], pool["steps"], pool["max_steps"],
+                 pool["high_water"]))
+    if pool["free"] > pool["largest"]:
+        print("  get_frames(n) fails for n > %d although %d frames are free"
+              % (pool["largest"], pool["free"]))
+    for problem in check(pool):
+        print("  WARNING: " + problem)
+    print()
+    for line in heatmap(pool, width, rows):
+        print("  " + line)
+    print()
+    for line in size_classes(pool):
+        print("  " + line)
+    print()
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Print the frame pool snapshots in the debug port output.")
+    parser.add_argument("files", nargs="*", metavar="FILE",
+                        help="captured output (default: standard input)")
+    parser.add_argument("-w", "--width", type=int, default=64,
+                        help="heatmap characters per line (default 64)")
+    parser.add_argument("-r", "--rows", type=int, default=16,
+                        help="heatmap lines per pool, at most (default 16)")
+    parser.add_argument("-a", "--all", action="store_true",
+                        help="show every snapshot, not only the last one")
+    args = parser.parse_args()
+
+    lines = []
+    if not args.files:
+        lines = sys.stdin.read().splitlines()
+    for name in args.files:
+        with open(name, errors="replace") as f:
+            lines.extend(f.read().splitlines())
+
+    snapshots = read_snapshots(lines)
+    if not snapshots:
+        sys.exit("no complete snapshot found")
+    if not args.all:
+        snapshots = snapshots[-1:]
+    for n, pools in enumerate(snapshots):
+        if args.all:
+            print("==== snapshot %d ====" % n)
+        for pool in pools:
+            print_pool(pool, args.width, args.rows)
+
+
+if __name__ == "__main__":
+    main()
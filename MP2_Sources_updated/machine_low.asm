@@ -15,4 +15,90 @@ global _get_EFLAGS
 _get_EFLAGS:
 	pushfd			; push eflags
 	pop	eax		; pop contents into eax
-	ret
\ No newline at end of file
+	ret
+
+; ----------------------------------------------------------------------
+; rdtsc()
+;
+; Returns the time-stamp counter in edx:eax. Not serializing: the CPU
+; may execute it before earlier instructions have completed.
+;
+; ----------------------------------------------------------------------
+global _rdtsc
+_rdtsc:
+	rdtsc			; edx:eax = TSC
+	ret
+
+; ----------------------------------------------------------------------
+; rdtsc_serialized()
+;
+; Same as rdtsc(), but executes cpuid first, which waits until all
+; earlier instructions have completed.
+;
+; ----------------------------------------------------------------------
+global _rdtsc_serialized
+_rdtsc_serialized:
+	push	ebx		; cpuid overwrites ebx, which is callee-saved
+	xor	eax, eax
+	cpuid
+	rdtsc
+	pop	ebx
+	ret
+
+; ----------------------------------------------------------------------
+; rdtscp()
+;
+; Returns the time-stamp counter in edx:eax, after all earlier
+; instructions have completed. Only on CPUs that support RDTSCP.
+;
+; ----------------------------------------------------------------------
+global _rdtscp
+_rdtscp:
+	rdtscp			; edx:eax = TSC, ecx = TSC_AUX (ignored)
+	ret
+
+; ----------------------------------------------------------------------
+; cpuid(leaf, regs)
+;
+; Executes cpuid for the given leaf (sub-leaf 0) and stores eax, ebx,
+; ecx and edx in regs[0..3].
+;
+; ----------------------------------------------------------------------
+global _cpuid
+_cpuid:
+	push	ebx
+	push	edi
+	mov	eax, [esp+12]	; leaf
+	mov	edi, [esp+16]	; regs
+	xor	ecx, ecx
+	cpuid
+	mov	[edi], eax
+	mov	[edi+4], ebx
+	mov	[edi+8], ecx
+	mov	[edi+12], edx
+	pop	edi
+	pop	ebx
+	ret
+
+; ----------------------------------------------------------------------
+; load_gdt(gdt_ptr, gs_selector)
+;
+; Loads the GDT described by gdt_ptr (16-bit limit, 32-bit base),
+; reloads cs with selector 0x08 and ds, es, fs and ss with selector
+; 0x10, and loads gs with gs_selector.
+;
+; ----------------------------------------------------------------------
+global _load_gdt
+_load_gdt:
+	mov	eax, [esp+4]	; gdt_ptr
+	lgdt	[eax]
+	jmp	0x08:.reload_cs	; a far jump reloads cs
+.reload_cs:
+	mov	ax, 0x10
+	mov	ds, ax
+	mov	es, ax
+	mov	fs, ax
+	mov	ss, ax
+	mov	eax, [esp+8]	; gs_selector
+	mov	gs, ax
+	ret
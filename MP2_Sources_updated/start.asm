@@ -43,8 +43,10 @@ mboot:
 ; will insert an 'extern _main', followed by 'call _main', right
 ; before the 'jmp $'.
 stublet:
-    extern _main
-    call _main
+    extern _kernel_main
+    push ebx                ; address of the Multiboot information
+    push eax                ; Multiboot magic number
+    call _kernel_main
     jmp $
 
 ; Here is the definition of our BSS section. Right now, we'll use